@@ -0,0 +1,202 @@
+// Kokoro Benchmark - Synthetic program generator
+// By Kuroshio Industrial Logic Systems
+//
+// Writes a large, valid Kokoro program for throughput testing of the
+// compiler. The mix leans on the paths that grow with program size:
+// symbol lookups (get_var_address), math_eval, IF blocks, array literals
+// and PRINT strings.
+//
+// Limits of the current compiler are respected on purpose:
+//  - at most MAX_VARS + MAX_ARRAYS distinct names; the symbol table is a
+//    fixed 256 entries with no bounds check, so it is not scaled with size
+//  - no 'i' in names or expressions (STORE scans up to the first 'i')
+//  - every line fits in MAX_LINE (256) characters
+//  - memory addresses use no 'A' hex digit (memory writes scan up to 'a')
+//  - IF blocks are long rather than nested (nested IF is not parsed yet)
+//
+// With --periodic it instead writes the same statement over and over, the
+// worst case for the -Os outliner (every repeat nests inside a longer one).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_VARS 200
+#define MAX_ARRAYS 16
+#define ARRAY_LEN 40
+#define IF_BODY_MAX 24
+#define PRINT_LEN_MAX 120
+
+static unsigned long rng_state = 1;
+
+static unsigned long rng_next(void)
+{
+    // Plain LCG so runs are reproducible across platforms
+    rng_state = rng_state * 1103515245UL + 12345UL;
+    return (rng_state >> 16) & 0x7FFF;
+}
+
+static int rng_range(int n)
+{
+    return (int)(rng_next() % (unsigned long)n);
+}
+
+// Names avoid 'i' entirely: v + two letters from the alphabet below
+static void var_name(int n, char *out)
+{
+    static const char letters[] = "abcdefghjklmnopqrstuvwxyz";
+    sprintf(out, "v%c%c", letters[(n / 25) % 25], letters[n % 25]);
+}
+
+static void array_name(int n, char *out)
+{
+    sprintf(out, "arr%d", n);
+}
+
+static void random_operand(char *out, int vars_used)
+{
+    if (vars_used > 0 && rng_range(3) != 0) {
+        var_name(rng_range(vars_used), out);
+    } else {
+        sprintf(out, "%d", 1 + rng_range(250));
+    }
+}
+
+// Emits one simple statement (anything that is legal inside an IF block)
+static void emit_simple(FILE *out, int *vars_used, int *arrays_used)
+{
+    static const char ops[] = "+-*/";
+    char dest[16], left[16], right[16];
+    int kind = rng_range(100);
+
+    // Grow the variable pool slowly so lookups hit both old and new names
+    int dest_index = *vars_used < MAX_VARS && rng_range(4) == 0
+                     ? (*vars_used)++
+                     : rng_range(*vars_used > 0 ? *vars_used : 1);
+    if (*vars_used == 0) *vars_used = 1;
+    var_name(dest_index, dest);
+
+    if (kind < 40) {
+        random_operand(left, *vars_used);
+        random_operand(right, *vars_used);
+        fprintf(out, "STORE %s %c %s IN %s AS NUMBER\n", left, ops[rng_range(4)], right, dest);
+    } else if (kind < 65) {
+        random_operand(left, *vars_used);
+        fprintf(out, "STORE %s IN %s AS NUMBER\n", left, dest);
+    } else if (kind < 75 && *arrays_used > 0) {
+        char arr[16];
+        array_name(rng_range(*arrays_used), arr);
+        fprintf(out, "STORE %s's ARRAY VALUE %d IN %s AS NUMBER\n", arr, 1 + rng_range(ARRAY_LEN), dest);
+    } else if (kind < 85) {
+        fprintf(out, "STORE %d IN MEMORY C%03d AS NUMBER\n", rng_range(256), rng_range(1000));
+    } else if (kind < 95) {
+        fprintf(out, "STORE MEMORY C%03d IN %s AS NUMBER\n", rng_range(1000), dest);
+    } else {
+        fprintf(out, "PRINT %s\n", dest);
+    }
+}
+
+static void emit_array(FILE *out, int *arrays_used)
+{
+    char name[16];
+    int index = *arrays_used < MAX_ARRAYS ? (*arrays_used)++ : rng_range(MAX_ARRAYS);
+    array_name(index, name);
+
+    fprintf(out, "STORE ");
+    for (int i = 0; i < ARRAY_LEN; i++) {
+        fprintf(out, "%d%s", rng_range(256), i + 1 < ARRAY_LEN ? ", " : "");
+    }
+    fprintf(out, " IN %s AS ARRAY OF %d NUMBERS\n", name, ARRAY_LEN);
+}
+
+static void emit_print_string(FILE *out)
+{
+    static const char text[] = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG ";
+    int len = 20 + rng_range(PRINT_LEN_MAX - 20);
+
+    fprintf(out, "PRINT \"");
+    for (int i = 0; i < len; i++) {
+        fputc(text[i % (sizeof(text) - 1)], out);
+    }
+    fprintf(out, "\"\n");
+}
+
+// Emits an IF block of at most `budget` statements (header included)
+static int emit_if(FILE *out, int *vars_used, int *arrays_used, int budget)
+{
+    static const char *cmps[] = { "GREATER_THAN", "LESS_THAN", "EQUAL_TO", "NOT_EQUAL_TO" };
+    char left[16], right[16];
+
+    if (*vars_used == 0) *vars_used = 1;
+    var_name(rng_range(*vars_used), left);
+    random_operand(right, *vars_used);
+
+    int body = 1 + rng_range(IF_BODY_MAX);
+    if (body > budget - 1) body = budget - 1;
+
+    fprintf(out, "IF %s IS %s %s DO {\n", left, cmps[rng_range(4)], right);
+    for (int i = 0; i < body; i++) {
+        fprintf(out, "    ");
+        emit_simple(out, vars_used, arrays_used);
+    }
+    fprintf(out, "}\n");
+    return body + 1;
+}
+
+int main(int argc, char *argv[])
+{
+    int periodic = argc > 1 && strcmp(argv[1], "--periodic") == 0;
+    if (periodic) {
+        argv++;
+        argc--;
+    }
+
+    if (argc < 3) {
+        printf("Usage: kokoro_gen [--periodic] statements output.kokoro [seed]\n");
+        return 1;
+    }
+
+    long statements = atol(argv[1]);
+    if (argc > 3) rng_state = strtoul(argv[3], NULL, 10);
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        perror("Error opening output file");
+        return 1;
+    }
+
+    fprintf(out, "# Synthetic Kokoro benchmark program: %ld statements\n", statements);
+
+    if (periodic) {
+        for (long i = 0; i < statements; i++) {
+            fprintf(out, "STORE 1 IN x AS NUMBER\n");
+        }
+        fclose(out);
+        printf("Wrote %ld periodic statements to %s\n", statements, argv[2]);
+        return 0;
+    }
+
+    int vars_used = 0, arrays_used = 0;
+    long written = 0;
+    while (written < statements) {
+        int kind = rng_range(1000);
+        if (kind < 2) {
+            emit_print_string(out);
+            written++;
+        } else if (kind < 12) {
+            emit_array(out, &arrays_used);
+            written++;
+        } else if (kind < 80 && statements - written > 2) {
+            long remaining = statements - written;
+            int budget = remaining > IF_BODY_MAX + 1 ? IF_BODY_MAX + 1 : (int)remaining;
+            written += emit_if(out, &vars_used, &arrays_used, budget);
+        } else {
+            emit_simple(out, &vars_used, &arrays_used);
+            written++;
+        }
+    }
+
+    fclose(out);
+    printf("Wrote %ld statements to %s\n", written, argv[2]);
+    return 0;
+}
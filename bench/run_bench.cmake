@@ -0,0 +1,76 @@
+# run_bench.cmake - Kokoro compiler throughput benchmark
+#
+# Invoked by the `bench` target. For each size in SIZES it generates a
+# synthetic program with kokoro_gen, compiles it with `kokoro --stats`
+# (and with -Os for sizes up to OS_MAX), and collects the per-phase
+# lines/sec, output size and peak memory, plus the front end breakdown
+# from a separate --stats=functions run, into WORK_DIR/results.txt.
+#
+# Inputs: KOKORO, GEN, WORK_DIR, SIZES (comma separated), OS_MAX
+
+string(REPLACE "," ";" SIZES "${SIZES}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+set(results "${WORK_DIR}/results.txt")
+set(header "statements  mode    phase         lines    seconds    lines/sec   output bytes    peak KB")
+file(WRITE "${results}" "${header}\n")
+message(STATUS "${header}")
+
+foreach(size IN LISTS SIZES)
+    set(source "${WORK_DIR}/bench_${size}.kokoro")
+    execute_process(
+        COMMAND "${GEN}" ${size} "${source}"
+        OUTPUT_QUIET
+        RESULT_VARIABLE gen_result)
+    if(NOT gen_result EQUAL 0)
+        message(FATAL_ERROR "kokoro_gen failed for ${size} statements")
+    endif()
+
+    # O0 and Os give the phase rows from an untimed --stats run. fn is a
+    # separate plain compile with --stats=functions that gives only the
+    # front end breakdown, so its clock() calls never reach a phase row.
+    set(modes "O0")
+    if(size LESS_EQUAL OS_MAX)
+        list(APPEND modes "Os")
+    endif()
+    list(APPEND modes "fn")
+
+    foreach(mode IN LISTS modes)
+        set(flags --stats)
+        set(pattern "^  (codegen|outline|total) ")
+        if(mode STREQUAL "Os")
+            list(APPEND flags -Os)
+        elseif(mode STREQUAL "fn")
+            set(flags --stats=functions)
+            set(pattern "^  (get_var_address|math_eval|keyword) ")
+        endif()
+
+        # The compiler prints a DEBUG line per statement, so send its
+        # stdout to a log file and pick the stats rows back out
+        set(log "${WORK_DIR}/bench_${size}_${mode}.log")
+        execute_process(
+            COMMAND "${KOKORO}" ${flags} "${source}" "${WORK_DIR}/bench_${size}_${mode}.asm"
+            OUTPUT_FILE "${log}"
+            RESULT_VARIABLE kokoro_result)
+        if(NOT kokoro_result EQUAL 0)
+            message(FATAL_ERROR "kokoro failed on ${source} (${mode}), see ${log}")
+        endif()
+
+        file(STRINGS "${log}" rows REGEX "${pattern}")
+        foreach(row IN LISTS rows)
+            string(REGEX REPLACE "^  " "" row "${row}")
+            set(line "")
+            string(APPEND line "${size}")
+            string(LENGTH "${size}" pad)
+            math(EXPR pad "12 - ${pad}")
+            foreach(i RANGE 1 ${pad})
+                string(APPEND line " ")
+            endforeach()
+            string(APPEND line "${mode}      ${row}")
+            file(APPEND "${results}" "${line}\n")
+            message(STATUS "${line}")
+        endforeach()
+    endforeach()
+endforeach()
+
+message(STATUS "Results written to ${results}")
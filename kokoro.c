@@ -5,6 +5,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
 
 #define TARGET_6502 1
 #define TARGET_MEGA6502 2
@@ -32,10 +40,33 @@ Symbol symbols[MAX_SYMBOLS];
 int symbol_count = 0;
 int next_address = START_ADDR;
 
+long source_lines = 0;   // every input line read, including IF block bodies
+
+// Front end breakdown for --stats. Parsing, symbol lookup and emission all
+// happen in one pass, so these are measured inside the codegen phase.
+#define STAT_STORE 0
+#define STAT_PRINT 1
+#define STAT_CALL 2
+#define STAT_BOOKMARK 3
+#define STAT_GOTO 4
+#define STAT_IF 5
+#define STAT_UNKNOWN 6
+#define STAT_HANDLERS 7
+
+int time_functions = 0;  // per-call clock() timers, only with --stats=functions
+long handler_lines[STAT_HANDLERS];
+const char *handler_names[STAT_HANDLERS] = {
+    "store", "print", "call", "bookmark", "goto", "if", "unknown"
+};
+long var_lookup_calls = 0;
+clock_t var_lookup_clock = 0;
+long math_eval_calls = 0;
+clock_t math_eval_clock = 0;
+
 
 
 // --- Symbol Table Management ---
-int get_var_address(const char *name, int size, int is_array) {
+static int lookup_var_address(const char *name, int size, int is_array) {
     for (int i = 0; i < symbol_count; i++) {
         if (strcmp(symbols[i].name, name) == 0) {
             return symbols[i].address;
@@ -51,6 +82,16 @@ int get_var_address(const char *name, int size, int is_array) {
     return addr;
 }
 
+int get_var_address(const char *name, int size, int is_array) {
+    var_lookup_calls++;
+    if (!time_functions) return lookup_var_address(name, size, is_array);
+
+    clock_t started = clock();
+    int addr = lookup_var_address(name, size, is_array);
+    var_lookup_clock += clock() - started;
+    return addr;
+}
+
 int is_constant(char *s)
 {
     // Simple: is it all digits? Then it's a constant.
@@ -81,6 +122,53 @@ void math_eval(char *expr, char *result, FILE *output);
 void emit_multiply(char *left, char *right, FILE *output);
 void emit_divide(char *left, char *right, FILE *output);
 void trim_cr(char *s);
+void outline_sequences(FILE *input, FILE *output, int min_save);
+long peak_memory_kb(void);
+void print_phase_stats(const char *phase, double seconds, long output_bytes, long peak_kb);
+void print_front_end_stats(void);
+
+// --- Compile statistics (--stats) ---
+long peak_memory_kb(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return (long)(counters.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;   // bytes on macOS
+#else
+    return usage.ru_maxrss;          // kilobytes on Linux/BSD
+#endif
+#endif
+}
+
+void print_phase_stats(const char *phase, double seconds, long output_bytes, long peak_kb)
+{
+    printf("  %-8s %10ld %10.3f %12.0f %14ld %10ld\n", phase, source_lines, seconds,
+           seconds > 0 ? source_lines / seconds : 0.0, output_bytes, peak_kb);
+}
+
+void print_front_end_stats(void)
+{
+    printf("Kokoro Front End Breakdown (single pass, inside codegen):\n");
+    if (time_functions) {
+        printf("  %-24s calls %10ld  seconds %8.3f\n", "get_var_address",
+               var_lookup_calls, (double)var_lookup_clock / CLOCKS_PER_SEC);
+        printf("  %-24s calls %10ld  seconds %8.3f\n", "math_eval",
+               math_eval_calls, (double)math_eval_clock / CLOCKS_PER_SEC);
+    } else {
+        // Untimed so the phase rows above are not skewed by clock() calls
+        printf("  %-24s calls %10ld\n", "get_var_address", var_lookup_calls);
+        printf("  %-24s calls %10ld\n", "math_eval", math_eval_calls);
+    }
+    for (int i = 0; i < STAT_HANDLERS; i++) {
+        printf("  keyword %-16s lines %10ld\n", handler_names[i], handler_lines[i]);
+    }
+}
 
 void trim_cr(char *s) {
     char *cr = strchr(s, '\r');
@@ -90,27 +178,80 @@ void trim_cr(char *s) {
 // --- Main ---
 int main(int argc, char *argv[])
 {
-    if (argc < 3) {
-        printf("Usage: kokoro input.kokoro output.asm\n");
+    int optimize_size = 0;
+    int outline_min_save = 1;
+    int show_stats = 0;
+    int has_min_save = 0;
+    int bad_args = 0;
+    char *input_path = NULL;
+    char *output_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-Os") == 0) {
+            optimize_size = 1;
+        } else if (strncmp(argv[i], "--outline-min-save=", 19) == 0) {
+            outline_min_save = atoi(argv[i] + 19);
+            if (outline_min_save < 1) outline_min_save = 1;
+            has_min_save = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            show_stats = 1;
+        } else if (strcmp(argv[i], "--stats=functions") == 0) {
+            show_stats = 1;
+            time_functions = 1;
+        } else if (argv[i][0] == '-') {
+            printf("Unknown option: %s\n", argv[i]);
+            bad_args = 1;
+        } else if (!input_path) {
+            input_path = argv[i];
+        } else if (!output_path) {
+            output_path = argv[i];
+        } else {
+            printf("Unexpected argument: %s\n", argv[i]);
+            bad_args = 1;
+        }
+    }
+
+    if (has_min_save && !optimize_size) {
+        printf("--outline-min-save only applies with -Os\n");
+        bad_args = 1;
+    }
+
+    if (bad_args || !input_path || !output_path) {
+        printf("Usage: kokoro [-Os] [--outline-min-save=N] [--stats[=functions]] input.kokoro output.asm\n");
         return 1;
     }
 
-    FILE *input = fopen(argv[1], "r");
+    FILE *input = fopen(input_path, "r");
     if (!input) {
         perror("Error opening input file");
         return 1;
     }
 
-    FILE *output = fopen(argv[2], "w");
-    if (!output) {
+    FILE *final_output = fopen(output_path, "w");
+    if (!final_output) {
         perror("Error opening output file");
         fclose(input);
         return 1;
     }
 
+    // With -Os, code is generated into a scratch file first so the
+    // outliner can see the whole instruction stream before writing it out
+    FILE *output = final_output;
+    if (optimize_size) {
+        output = tmpfile();
+        if (!output) {
+            perror("Error creating temporary file");
+            fclose(input);
+            fclose(final_output);
+            return 1;
+        }
+    }
+
     char line[MAX_LINE];
+    clock_t phase_start = clock();
 
     while (fgets(line, MAX_LINE, input)) {
+    source_lines++;
     char *start = line;
 
     // Skip leading whitespace
@@ -157,10 +298,40 @@ int main(int argc, char *argv[])
     }
 
     fclose(input);
-    fclose(output);
+
+    double codegen_seconds = (double)(clock() - phase_start) / CLOCKS_PER_SEC;
+    long codegen_bytes = ftell(output);
+    long codegen_peak_kb = peak_memory_kb();
+
+    double outline_seconds = 0.0;
+    long outline_bytes = 0;
+    if (optimize_size) {
+        phase_start = clock();
+        rewind(output);
+        outline_sequences(output, final_output, outline_min_save);
+        fclose(output);
+        outline_seconds = (double)(clock() - phase_start) / CLOCKS_PER_SEC;
+        outline_bytes = ftell(final_output);
+    }
+    fclose(final_output);
 
     print_memory_map();
 
+    if (show_stats) {
+        // Peak memory is process-wide, so each row shows the high-water mark
+        // reached by the end of that phase
+        printf("Kokoro Compile Stats:\n");
+        printf("  %-8s %10s %10s %12s %14s %10s\n",
+               "phase", "lines", "seconds", "lines/sec", "output bytes", "peak KB");
+        print_phase_stats("codegen", codegen_seconds, codegen_bytes, codegen_peak_kb);
+        if (optimize_size) {
+            print_phase_stats("outline", outline_seconds, outline_bytes, peak_memory_kb());
+        }
+        print_phase_stats("total", codegen_seconds + outline_seconds,
+                          optimize_size ? outline_bytes : codegen_bytes, peak_memory_kb());
+        print_front_end_stats();
+    }
+
     printf("Kokoro compile complete.\n");
     return 0;
 }
@@ -169,6 +340,7 @@ int main(int argc, char *argv[])
 
 void handle_store(char *line, FILE *output)
 {
+    handler_lines[STAT_STORE]++;
     // Bulk array assignment
     if (strstr(line, ",") && strstr(line, "as array")) {
         char values[256], var[32];
@@ -302,6 +474,7 @@ void handle_store(char *line, FILE *output)
 
 void handle_print(char *line, FILE *output)
 {
+    handler_lines[STAT_PRINT]++;
     char arg[256];
     sscanf(line, "print %255[^\n]", arg);
     trim_cr(arg);
@@ -396,6 +569,7 @@ void handle_print(char *line, FILE *output)
 
 void handle_call(char *line, FILE *output)
 {
+    handler_lines[STAT_CALL]++;
     char func[32];
     int n = sscanf(line, "call %31s", func);
     fprintf(output, "JSR %s\n\n", func);
@@ -403,6 +577,7 @@ void handle_call(char *line, FILE *output)
 
 void handle_bookmark(char *line, FILE *output)
 {
+    handler_lines[STAT_BOOKMARK]++;
     char name[32];
     int n = sscanf(line, "bookmark %31s", name);
     fprintf(output, "%s:\n\n", name);
@@ -410,6 +585,7 @@ void handle_bookmark(char *line, FILE *output)
 
 void handle_goto(char *line, FILE *output)
 {
+    handler_lines[STAT_GOTO]++;
     char name[32];
     int n = sscanf(line, "goto %31s", name);
     fprintf(output, "JMP %s\n\n", name);
@@ -418,6 +594,7 @@ void handle_goto(char *line, FILE *output)
 void handle_if(char *line, FILE *output, FILE *input)
 
 {
+    handler_lines[STAT_IF]++;
     char var1[32], var2[32], cmp[32];
     int n = sscanf(line, "if %31s is %31s %31s do {", var1, cmp, var2);
 
@@ -466,6 +643,7 @@ if (is_constant(var2)) {
 
     char block_line[MAX_LINE];
     while (fgets(block_line, MAX_LINE, input)) {   // You will need to pass input_file to handle_if!
+        source_lines++;
 
         // Strip leading whitespace
         char *start = block_line;
@@ -509,10 +687,27 @@ if (is_constant(var2)) {
 
 void handle_unknown(char *line, FILE *output)
 {
+    handler_lines[STAT_UNKNOWN]++;
     fprintf(output, "; Unknown line: %s\n\n", line);
 }
 
+static void eval_expression(char *expr, char *result, FILE *output);
+
 void math_eval(char *expr, char *result, FILE *output)
+{
+    math_eval_calls++;
+    if (!time_functions) {
+        eval_expression(expr, result, output);
+        return;
+    }
+
+    // Includes the get_var_address calls made while evaluating
+    clock_t started = clock();
+    eval_expression(expr, result, output);
+    math_eval_clock += clock() - started;
+}
+
+static void eval_expression(char *expr, char *result, FILE *output)
 {
     // Trim leading whitespace
     while (isspace((unsigned char)*expr)) expr++;
@@ -678,3 +873,548 @@ void emit_divide(char *left, char *right, FILE *output)
         fprintf(output, "DIV %s, %s\n", left, right);
     }
 }
+
+
+// --- Size optimization (-Os): repeated-sequence outlining ---
+//
+// Works on the finished instruction stream. Every emitted line becomes one
+// entry; identical lines share an id. Lines that must not move into a
+// subroutine (labels, branches, jumps, stack ops) get a unique id so no
+// repeat can span them. A suffix array + LCP over the ids finds repeated
+// runs; each round moves every non-overlapping run that still pays for
+// itself into a JSR/RTS subroutine, and rounds repeat until none does.
+
+#define OUTLINE_JSR_BYTES 3
+#define OUTLINE_RTS_BYTES 1
+#define OUTLINE_CALL_CYCLES 12   // JSR (6) + RTS (6)
+#define OUTLINE_ROUND_WORK 8     // occurrence positions sorted per round, per line
+
+typedef struct {
+    char *text;    // line as emitted, without newline
+    int id;        // equal ids == identical, outlinable lines
+    int bytes;     // estimated encoded size
+} AsmLine;
+
+typedef struct {
+    AsmLine *lines;
+    int count;
+    int capacity;
+} AsmStream;
+
+typedef struct {
+    char **body;
+    int length;
+    int bytes;
+    int calls;
+    int saved;
+} Outlined;
+
+// All outliner allocations go through here; running out of memory on a
+// big -Os compile stops the compiler rather than crashing it
+static void *checked_realloc(void *block, size_t size)
+{
+    void *grown = realloc(block, size > 0 ? size : 1);
+    if (!grown) {
+        perror("Out of memory");
+        exit(1);
+    }
+    return grown;
+}
+
+static void *checked_malloc(size_t size)
+{
+    return checked_realloc(NULL, size);
+}
+
+static char *dup_string(const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *copy = checked_malloc(len);
+    memcpy(copy, s, len);
+    return copy;
+}
+
+static void *grow_array(void *array, int *capacity, size_t item_size)
+{
+    *capacity = *capacity ? *capacity * 2 : 256;
+    return checked_realloc(array, (size_t)*capacity * item_size);
+}
+
+// Rough 6502 encoding size: implied/accumulator 1, immediate/zero page/
+// indirect 2, absolute or symbolic 3. Labels, comments and blanks are free.
+static int asm_line_bytes(const char *line)
+{
+    while (isspace((unsigned char)*line)) line++;
+    if (*line == '\0' || *line == ';') return 0;
+    if (line[strlen(line) - 1] == ':') return 0;
+
+    const char *operand = line;
+    while (*operand && !isspace((unsigned char)*operand)) operand++;
+    while (isspace((unsigned char)*operand)) operand++;
+
+    if (*operand == '\0' || *operand == ';') return 1;
+    if ((operand[0] == 'A' || operand[0] == 'a') &&
+        (operand[1] == '\0' || isspace((unsigned char)operand[1]))) return 1;
+    if (*operand == '#' || *operand == '(') return 2;
+    if (*operand == '$') {
+        int digits = 0;
+        while (isxdigit((unsigned char)operand[1 + digits])) digits++;
+        return digits <= 2 ? 2 : 3;
+    }
+    return 3;
+}
+
+// Lines that change control flow or touch the stack cannot be moved
+// behind a JSR without changing what they do.
+static int asm_line_outlinable(const char *line)
+{
+    static const char *fixed[] = {
+        "jmp", "jsr", "rts", "rti", "brk",
+        "bcc", "bcs", "beq", "bne", "bmi", "bpl", "bvc", "bvs", "bra",
+        "pha", "pla", "php", "plp", "tsx", "txs"
+    };
+
+    while (isspace((unsigned char)*line)) line++;
+    if (*line == '\0' || *line == ';') return 1;
+    if (line[strlen(line) - 1] == ':') return 0;
+
+    char mnemonic[8];
+    sscanf(line, "%7s", mnemonic);
+    for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+        if (strcasecmp(mnemonic, fixed[i]) == 0) return 0;
+    }
+    return 1;
+}
+
+// Reads one whole line of any length (comments can echo a full source line
+// plus a prefix, so MAX_LINE is not enough). Returns NULL at end of file.
+static char *read_asm_line(FILE *input)
+{
+    int capacity = MAX_LINE, length = 0;
+    char *line = checked_malloc(capacity);
+
+    while (fgets(line + length, capacity - length, input)) {
+        length += (int)strlen(line + length);
+        if (length > 0 && line[length - 1] == '\n') break;
+        if (length == capacity - 1) {
+            capacity *= 2;
+            line = checked_realloc(line, capacity);
+        }
+    }
+
+    if (length == 0) {
+        free(line);
+        return NULL;
+    }
+    line[strcspn(line, "\r\n")] = '\0';
+    return line;
+}
+
+static void stream_push(AsmStream *stream, char *text)
+{
+    if (stream->count == stream->capacity) {
+        stream->lines = grow_array(stream->lines, &stream->capacity, sizeof(AsmLine));
+    }
+    AsmLine *l = &stream->lines[stream->count++];
+    l->text = text;
+    l->id = -1;
+    l->bytes = asm_line_bytes(text);
+}
+
+// Give identical outlinable lines the same id, everything else a fresh one.
+// Returns the first unused id.
+static int stream_assign_ids(AsmStream *stream)
+{
+    int *order = checked_malloc(sizeof(int) * (stream->count + 1));
+    int n = 0;
+    for (int i = 0; i < stream->count; i++) {
+        stream->lines[i].id = -1;
+        if (asm_line_outlinable(stream->lines[i].text)) order[n++] = i;
+    }
+
+    // Bottom-up merge sort of line indices by text
+    int *scratch = checked_malloc(sizeof(int) * (n + 1));
+    for (int width = 1; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int a = lo, b = mid, k = lo;
+            while (a < mid && b < hi) {
+                if (strcmp(stream->lines[order[a]].text, stream->lines[order[b]].text) <= 0)
+                    scratch[k++] = order[a++];
+                else
+                    scratch[k++] = order[b++];
+            }
+            while (a < mid) scratch[k++] = order[a++];
+            while (b < hi) scratch[k++] = order[b++];
+        }
+        memcpy(order, scratch, sizeof(int) * n);
+    }
+
+    int next_id = 0;
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && strcmp(stream->lines[order[i]].text, stream->lines[order[i - 1]].text) != 0)
+            next_id++;
+        stream->lines[order[i]].id = next_id;
+    }
+    next_id++;
+    for (int i = 0; i < stream->count; i++) {
+        if (stream->lines[i].id < 0) stream->lines[i].id = next_id++;
+    }
+
+    free(scratch);
+    free(order);
+    return next_id;
+}
+
+// Prefix-doubling suffix array with a counting sort per step (O(n log n)),
+// followed by Kasai's LCP. Ids must be below id_limit.
+static void build_suffix_array(const AsmStream *stream, int id_limit, int *sa, int *lcp)
+{
+    int n = stream->count;
+    int range = id_limit > n ? id_limit : n;
+    int *rank = checked_malloc(sizeof(int) * n);
+    int *next = checked_malloc(sizeof(int) * n);
+    int *order = checked_malloc(sizeof(int) * n);
+    int *bucket = checked_malloc(sizeof(int) * (range + 1));
+
+    for (int i = 0; i < n; i++) order[i] = i;
+    for (int i = 0; i < n; i++) rank[i] = stream->lines[i].id;
+
+    for (int step = 1; ; step *= 2) {
+        // Stable counting sort by rank; on the first pass `order` is just the
+        // index order, afterwards it holds suffixes ordered by second key
+        memset(bucket, 0, sizeof(int) * (range + 1));
+        for (int i = 0; i < n; i++) bucket[rank[i] + 1]++;
+        for (int r = 0; r < range; r++) bucket[r + 1] += bucket[r];
+        for (int i = 0; i < n; i++) sa[bucket[rank[order[i]]]++] = order[i];
+
+        if (step > 1) {
+            next[sa[0]] = 0;
+            for (int i = 1; i < n; i++) {
+                int a = sa[i - 1], b = sa[i];
+                int half = step / 2;
+                int ra = a + half < n ? rank[a + half] : -1;
+                int rb = b + half < n ? rank[b + half] : -1;
+                next[b] = next[a] + (rank[a] != rank[b] || ra != rb);
+            }
+            memcpy(rank, next, sizeof(int) * n);
+            if (rank[sa[n - 1]] == n - 1) break;
+        }
+
+        // Order for the next pass by second key: suffixes with nothing
+        // `step` lines on come first, then the rest in current rank order
+        int k = 0;
+        for (int i = n - step > 0 ? n - step : 0; i < n; i++) order[k++] = i;
+        for (int i = 0; i < n; i++) {
+            if (sa[i] >= step) order[k++] = sa[i] - step;
+        }
+    }
+
+    int h = 0;
+    lcp[0] = 0;
+    for (int i = 0; i < n; i++) {
+        if (rank[i] == 0) {
+            h = 0;
+            continue;
+        }
+        int j = sa[rank[i] - 1];
+        while (i + h < n && j + h < n &&
+               stream->lines[i + h].id == stream->lines[j + h].id) h++;
+        lcp[rank[i]] = h;
+        if (h > 0) h--;
+    }
+
+    free(bucket);
+    free(order);
+    free(next);
+    free(rank);
+}
+
+static int compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Bytes saved by turning `calls` copies of a `bytes`-long run into JSRs
+static int outline_saving(int bytes, int calls)
+{
+    return calls * bytes - (calls * OUTLINE_JSR_BYTES + bytes + OUTLINE_RTS_BYTES);
+}
+
+// A repeated run: suffix array range [lb, rb] sharing `length` lines.
+// `bound` is the best saving it could reach: at most one call per
+// occurrence and no more calls than non-overlapping copies fit in the stream.
+typedef struct {
+    int lb;
+    int rb;
+    int length;
+    int bound;
+} Candidate;
+
+static int compare_candidate(const void *a, const void *b)
+{
+    const Candidate *x = a, *y = b;
+    if (x->bound != y->bound) return x->bound > y->bound ? -1 : 1;
+    return y->length - x->length;
+}
+
+// Collect every LCP interval whose best-case saving reaches min_save
+static Candidate *find_candidates(const AsmStream *stream, const int *sa, const int *lcp,
+                                  const int *prefix, int min_save, int *count)
+{
+    int n = stream->count;
+    int *stack_lcp = checked_malloc(sizeof(int) * (n + 1));
+    int *stack_lb = checked_malloc(sizeof(int) * (n + 1));
+    Candidate *cands = NULL;
+    int capacity = 0;
+    int top = 0;
+
+    *count = 0;
+    stack_lcp[0] = 0;
+    stack_lb[0] = 0;
+
+    for (int i = 1; i <= n; i++) {
+        int cur = i < n ? lcp[i] : 0;
+        int lb = i - 1;
+        while (cur < stack_lcp[top]) {
+            int length = stack_lcp[top];
+            lb = stack_lb[top];
+            top--;
+
+            int bytes = prefix[sa[lb] + length] - prefix[sa[lb]];
+            int calls = i - lb < n / length ? i - lb : n / length;
+            int bound = outline_saving(bytes, calls);
+            if (bound >= min_save) {
+                if (*count == capacity) {
+                    cands = grow_array(cands, &capacity, sizeof(Candidate));
+                }
+                Candidate *c = &cands[(*count)++];
+                c->lb = lb;
+                c->rb = i - 1;
+                c->length = length;
+                c->bound = bound;
+            }
+        }
+        if (cur > stack_lcp[top]) {
+            top++;
+            stack_lcp[top] = cur;
+            stack_lb[top] = lb;
+        }
+    }
+
+    free(stack_lb);
+    free(stack_lcp);
+    return cands;
+}
+
+// Fenwick tree over picked lines, so "is any line in [a, b) picked" is
+// O(log n) instead of a scan of the whole run
+static void picked_add(int *tree, int n, int i)
+{
+    for (i++; i <= n; i += i & -i) tree[i]++;
+}
+
+static int picked_before(const int *tree, int i)
+{
+    int sum = 0;
+    for (; i > 0; i -= i & -i) sum += tree[i];
+    return sum;
+}
+
+// One outlining round: take repeats, best first, whose occurrences that
+// are still free of other picks save at least min_save, then rewrite the
+// stream once. Returns the number of subroutines added.
+//
+// On repetitive code the LCP intervals nest and their sizes add up to
+// O(n^2), so a round stops once it has sorted OUTLINE_ROUND_WORK * n
+// occurrence positions; whatever is left is found again next round.
+static int outline_round(AsmStream *stream, int *next_id, int min_save, int guard_bytes,
+                         Outlined **subs, int *sub_count, int *sub_capacity)
+{
+    int n = stream->count;
+    if (n < 2) return 0;
+
+    int *sa = checked_malloc(sizeof(int) * n);
+    int *lcp = checked_malloc(sizeof(int) * n);
+    int *prefix = checked_malloc(sizeof(int) * (n + 1));
+    int *pos = checked_malloc(sizeof(int) * n);
+    int *call_at = checked_malloc(sizeof(int) * n);
+    char *taken = checked_malloc(n);
+    int *picked = checked_malloc(sizeof(int) * (n + 1));
+
+    build_suffix_array(stream, *next_id, sa, lcp);
+
+    prefix[0] = 0;
+    for (int i = 0; i < n; i++) prefix[i + 1] = prefix[i] + stream->lines[i].bytes;
+    for (int i = 0; i < n; i++) call_at[i] = -1;
+    memset(taken, 0, n);
+    memset(picked, 0, sizeof(int) * (n + 1));
+
+    int cand_count = 0;
+    Candidate *cands = find_candidates(stream, sa, lcp, prefix, min_save, &cand_count);
+    if (cand_count > 0) qsort(cands, cand_count, sizeof(Candidate), compare_candidate);
+
+    int added = 0;
+    long work = 0, work_limit = (long)OUTLINE_ROUND_WORK * n;
+    int free_bytes = prefix[n];
+    for (int c = 0; c < cand_count; c++) {
+        // The first subroutine also has to pay for the halt guard
+        int threshold = min_save + (*sub_count == 0 ? guard_bytes : 0);
+
+        // Candidates are sorted by bound, and no pick can save more than
+        // the bytes still unclaimed, so nothing after this can pay off
+        if (cands[c].bound < threshold || free_bytes < threshold) break;
+
+        // Mostly covered by an earlier pick, which was at least as good
+        if (taken[sa[cands[c].lb]]) continue;
+
+        int length = cands[c].length;
+        int count = cands[c].rb - cands[c].lb + 1;
+        if (work > 0 && work + count > work_limit) break;
+        work += count;
+
+        memcpy(pos, sa + cands[c].lb, sizeof(int) * count);
+        qsort(pos, count, sizeof(int), compare_int);
+
+        // Keep occurrences that overlap neither each other nor earlier picks
+        int calls = 0, last_end = -1;
+        for (int k = 0; k < count; k++) {
+            if (pos[k] < last_end) continue;
+            if (picked_before(picked, pos[k] + length) != picked_before(picked, pos[k])) continue;
+            pos[calls++] = pos[k];
+            last_end = pos[k] + length;
+        }
+
+        int bytes = prefix[pos[0] + length] - prefix[pos[0]];
+        int saving = calls > 0 ? outline_saving(bytes, calls) : 0;
+        if (calls < 2 || saving < threshold) continue;
+
+        if (*sub_count == *sub_capacity) {
+            *subs = grow_array(*subs, sub_capacity, sizeof(Outlined));
+        }
+        Outlined *sub = &(*subs)[*sub_count];
+        sub->body = checked_malloc(sizeof(char *) * length);
+        sub->length = length;
+        sub->bytes = bytes;
+        sub->calls = calls;
+        sub->saved = saving;
+        for (int k = 0; k < length; k++) {
+            sub->body[k] = dup_string(stream->lines[pos[0] + k].text);
+        }
+
+        for (int k = 0; k < calls; k++) {
+            for (int j = 0; j < length; j++) {
+                taken[pos[k] + j] = 1;
+                picked_add(picked, n, pos[k] + j);
+            }
+            call_at[pos[k]] = *sub_count;
+        }
+        free_bytes -= calls * bytes;
+        (*sub_count)++;
+        added++;
+    }
+
+    // Rebuild the stream with each picked occurrence replaced by a JSR.
+    // Only the new JSR lines need ids, and each gets a fresh one.
+    if (added > 0) {
+        int write = 0;
+        for (int read = 0; read < n; ) {
+            int s = call_at[read];
+            if (s >= 0) {
+                char call[64];
+                sprintf(call, "JSR kokoro_os_%d", s);
+                for (int k = 0; k < (*subs)[s].length; k++) free(stream->lines[read + k].text);
+                stream->lines[write].text = dup_string(call);
+                stream->lines[write].id = (*next_id)++;
+                stream->lines[write].bytes = OUTLINE_JSR_BYTES;
+                write++;
+                read += (*subs)[s].length;
+            } else {
+                stream->lines[write++] = stream->lines[read++];
+            }
+        }
+        stream->count = write;
+    }
+
+    free(cands);
+    free(picked);
+    free(taken);
+    free(call_at);
+    free(pos);
+    free(prefix);
+    free(lcp);
+    free(sa);
+    return added;
+}
+
+void outline_sequences(FILE *input, FILE *output, int min_save)
+{
+    AsmStream stream = {0};
+    char *text;
+
+    while ((text = read_asm_line(input)) != NULL) {
+        stream_push(&stream, text);
+    }
+
+    int original_bytes = 0;
+    for (int i = 0; i < stream.count; i++) original_bytes += stream.lines[i].bytes;
+
+    Outlined *subs = NULL;
+    int sub_count = 0, sub_capacity = 0;
+
+    // Halt guard placed in front of the subroutine block
+    int guard_bytes = OUTLINE_JSR_BYTES;
+
+    int next_id = stream_assign_ids(&stream);
+    while (outline_round(&stream, &next_id, min_save, guard_bytes,
+                         &subs, &sub_count, &sub_capacity) > 0) {
+    }
+
+    for (int i = 0; i < stream.count; i++) {
+        fprintf(output, "%s\n", stream.lines[i].text);
+    }
+
+    int final_bytes = 0;
+    for (int i = 0; i < stream.count; i++) final_bytes += stream.lines[i].bytes;
+
+    if (sub_count > 0) {
+        // Falling off the end of the program must not run into a subroutine
+        fprintf(output, "; --- -Os outlined subroutines ---\n");
+        fprintf(output, "kokoro_os_halt:\n");
+        fprintf(output, "JMP kokoro_os_halt\n\n");
+        final_bytes += guard_bytes;
+
+        for (int s = 0; s < sub_count; s++) {
+            fprintf(output, "kokoro_os_%d:\n", s);
+            for (int k = 0; k < subs[s].length; k++) {
+                fprintf(output, "%s\n", subs[s].body[k]);
+            }
+            fprintf(output, "RTS\n\n");
+            final_bytes += subs[s].bytes + OUTLINE_RTS_BYTES;
+        }
+    }
+
+    int total_calls = 0;
+    printf("Kokoro -Os Outlining Report:\n");
+    for (int s = 0; s < sub_count; s++) {
+        printf("  kokoro_os_%-6d %3d lines, %3d bytes, %3d calls: -%d bytes, +%d cycles/call\n",
+               s, subs[s].length, subs[s].bytes, subs[s].calls,
+               subs[s].saved, OUTLINE_CALL_CYCLES);
+        total_calls += subs[s].calls;
+    }
+    printf("  code size: %d -> %d bytes (saved %d, incl. %d byte halt guard)\n",
+           original_bytes, final_bytes, original_bytes - final_bytes,
+           sub_count > 0 ? guard_bytes : 0);
+    printf("  JSR/RTS overhead: %d call sites, +%d cycles if each runs once\n",
+           total_calls, total_calls * OUTLINE_CALL_CYCLES);
+
+    for (int s = 0; s < sub_count; s++) {
+        for (int k = 0; k < subs[s].length; k++) free(subs[s].body[k]);
+        free(subs[s].body);
+    }
+    free(subs);
+    for (int i = 0; i < stream.count; i++) free(stream.lines[i].text);
+    free(stream.lines);
+}
@@ -0,0 +1,114 @@
+# check_outline.cmake - -Os outliner test
+#
+# Compiles SOURCE with `kokoro -Os ${FLAGS}` and checks two things:
+#  - if EXPECTED is given, the output matches that golden .asm file
+#  - inlining every JSR kokoro_os_N back into its call site reproduces
+#    the plain (no -Os) output exactly
+#
+# If GEN is given, SOURCE is first generated with
+# `kokoro_gen ${GEN_FLAGS} ${STATEMENTS}`.
+#
+# Inputs: KOKORO, SOURCE, WORK_DIR, [EXPECTED], [FLAGS],
+#         [GEN, STATEMENTS, GEN_FLAGS]
+
+file(MAKE_DIRECTORY "${WORK_DIR}")
+get_filename_component(name "${SOURCE}" NAME_WE)
+
+if(GEN)
+    execute_process(
+        COMMAND "${GEN}" ${GEN_FLAGS} ${STATEMENTS} "${SOURCE}"
+        OUTPUT_QUIET
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "kokoro_gen failed for ${STATEMENTS} statements")
+    endif()
+endif()
+
+set(os_asm "${WORK_DIR}/${name}_os.asm")
+set(plain_asm "${WORK_DIR}/${name}_plain.asm")
+
+execute_process(
+    COMMAND "${KOKORO}" -Os ${FLAGS} "${SOURCE}" "${os_asm}"
+    OUTPUT_QUIET
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "kokoro -Os failed on ${SOURCE}")
+endif()
+
+execute_process(
+    COMMAND "${KOKORO}" "${SOURCE}" "${plain_asm}"
+    OUTPUT_QUIET
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "kokoro failed on ${SOURCE}")
+endif()
+
+# Reads a file as a list of lines. Assembly comments contain ';' and source
+# echoes can contain '[' or ']', which CMake lists treat specially, so
+# they are swapped for placeholders. Every line gets a '|' prefix so blank
+# lines survive as list elements.
+function(read_lines path out)
+    file(READ "${path}" text)
+    string(REPLACE "\r\n" "\n" text "${text}")
+    string(REPLACE ";" "<semi>" text "${text}")
+    string(REPLACE "[" "<lb>" text "${text}")
+    string(REPLACE "]" "<rb>" text "${text}")
+    string(REPLACE "\n" ";|" text "|${text}")
+    set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+read_lines("${os_asm}" os_lines)
+read_lines("${plain_asm}" plain_lines)
+
+if(EXPECTED)
+    read_lines("${EXPECTED}" expected_lines)
+    if(NOT os_lines STREQUAL expected_lines)
+        message(FATAL_ERROR "${os_asm} does not match ${EXPECTED}")
+    endif()
+endif()
+
+# Split the -Os output into the main program and the subroutine bodies
+set(main "")
+set(in_subs FALSE)
+set(current "")
+set(sub_names "")
+foreach(line IN LISTS os_lines)
+    if(line STREQUAL "|<semi> --- -Os outlined subroutines ---")
+        set(in_subs TRUE)
+    elseif(NOT in_subs)
+        list(APPEND main "${line}")
+    elseif(line MATCHES "^\\|(kokoro_os_[0-9]+):$")
+        set(current "${CMAKE_MATCH_1}")
+        set(body_${current} "")
+        list(APPEND sub_names "${current}")
+    elseif(line STREQUAL "|RTS")
+        set(current "")
+    elseif(current)
+        list(APPEND body_${current} "${line}")
+    endif()
+endforeach()
+
+if(in_subs)
+    # Writing a line per entry plus the final newline ends with an empty line
+    list(APPEND main "|")
+endif()
+
+set(expanded "")
+foreach(line IN LISTS main)
+    if(line MATCHES "^\\|JSR (kokoro_os_[0-9]+)$")
+        list(FIND sub_names "${CMAKE_MATCH_1}" index)
+        if(index LESS 0)
+            message(FATAL_ERROR "${os_asm} calls missing subroutine ${CMAKE_MATCH_1}")
+        endif()
+        list(APPEND expanded ${body_${CMAKE_MATCH_1}})
+    else()
+        list(APPEND expanded "${line}")
+    endif()
+endforeach()
+
+if(NOT expanded STREQUAL plain_lines)
+    message(FATAL_ERROR "Inlining the subroutines in ${os_asm} does not give ${plain_asm}")
+endif()
+
+list(LENGTH sub_names count)
+message(STATUS "${name}: ${count} subroutines, inlined output matches plain output")
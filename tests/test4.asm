@@ -0,0 +1,119 @@
+LDA #7
+STA $0200
+
+LDA #9
+STA $0201
+
+JSR kokoro_os_0
+LDA #104
+JSR kokoro_os_1
+BNE print_continue_0
+JSR kokoro_os_2
+print_continue_0:
+JSR kokoro_os_0
+LDA #105
+JSR kokoro_os_1
+BNE print_continue_1
+JSR kokoro_os_2
+print_continue_1:
+
+JSR kokoro_os_0
+LDA #111
+JSR kokoro_os_1
+BNE print_continue_0
+JSR kokoro_os_2
+print_continue_0:
+JSR kokoro_os_0
+LDA #107
+JSR kokoro_os_1
+BNE print_continue_1
+JSR kokoro_os_2
+print_continue_1:
+
+JSR kokoro_os_0
+LDA $0200
+JSR kokoro_os_1
+BNE print_continue_var
+JSR kokoro_os_2
+print_continue_var:
+
+LDA $0200
+CMP $0201
+BCS skip_if_0
+JSR kokoro_os_0
+LDA #121
+JSR kokoro_os_1
+BNE print_continue_0
+JSR kokoro_os_2
+print_continue_0:
+JSR kokoro_os_0
+LDA #101
+JSR kokoro_os_1
+BNE print_continue_1
+JSR kokoro_os_2
+print_continue_1:
+JSR kokoro_os_0
+LDA #115
+JSR kokoro_os_1
+BNE print_continue_2
+JSR kokoro_os_2
+print_continue_2:
+
+skip_if_0:
+
+LDA $0200
+CMP $0201
+BEQ skip_if_1
+JSR kokoro_os_0
+LDA $0201
+JSR kokoro_os_1
+BNE print_continue_var
+JSR kokoro_os_2
+print_continue_var:
+
+skip_if_1:
+
+; --- -Os outlined subroutines ---
+kokoro_os_halt:
+JMP kokoro_os_halt
+
+kokoro_os_0:
+; 6502 multiply: $F003 * 40
+LDA $F003
+STA $F004
+LDA $F004
+ASL A
+ASL A
+ASL A
+ASL A
+ASL A
+STA $F005
+LDA $F004
+ASL A
+ASL A
+ASL A
+STA $F006
+CLC
+LDA $F005
+ADC $F006
+CLC
+ADC $F002
+STA temp_addr_low
+LDA #E0
+STA temp_addr_high
+RTS
+
+kokoro_os_1:
+LDY #0
+STA (temp_addr_low),Y
+INC $F002
+LDA $F002
+CMP #40
+RTS
+
+kokoro_os_2:
+LDA #0
+STA $F002
+INC $F003
+RTS
+
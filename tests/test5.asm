@@ -0,0 +1,93 @@
+LDA #1
+STA $0200
+
+LDA #2
+STA $0201
+JSR kokoro_os_0
+LDA $0200
+LDY #0
+STA (temp_addr_low),Y
+INC $F002
+LDA $F002
+CMP #40
+BNE print_continue_var
+LDA #0
+STA $F002
+INC $F003
+print_continue_var:
+JSR kokoro_os_0
+LDA $0201
+LDY #0
+STA (temp_addr_low),Y
+INC $F002
+LDA $F002
+CMP #40
+BNE print_continue_var
+LDA #0
+STA $F002
+INC $F003
+print_continue_var:
+
+LDA $0200
+CMP $0201
+BCS skip_if_0
+LDA #3
+STA $0202
+
+skip_if_0:
+
+LDA $0200
+CMP $0201
+BCS skip_if_1
+LDA #4
+STA $0203
+
+skip_if_1:
+
+LDA $0200
+CMP $0201
+BCS skip_if_2
+LDA #5
+STA $0204
+
+skip_if_2:
+
+LDA $0200
+CMP $0201
+BCS skip_if_3
+LDA #6
+STA $0205
+
+skip_if_3:
+
+; --- -Os outlined subroutines ---
+kokoro_os_halt:
+JMP kokoro_os_halt
+
+kokoro_os_0:
+
+; 6502 multiply: $F003 * 40
+LDA $F003
+STA $F004
+LDA $F004
+ASL A
+ASL A
+ASL A
+ASL A
+ASL A
+STA $F005
+LDA $F004
+ASL A
+ASL A
+ASL A
+STA $F006
+CLC
+LDA $F005
+ADC $F006
+CLC
+ADC $F002
+STA temp_addr_low
+LDA #E0
+STA temp_addr_high
+RTS
+